@@ -20,7 +20,7 @@
 using ExamplePlugin = Plugin.Example.Empty.NativeInterop.Plugin;
 
 var data = IntPtr.Zero;
-ExamplePlugin.Initialize(ref data, IntPtr.Zero);
+ExamplePlugin.Initialize(ref data, IntPtr.Zero, IntPtr.Zero);
 
 Console.WriteLine(ExamplePlugin.Update(data));
 await Task.Delay(1000);
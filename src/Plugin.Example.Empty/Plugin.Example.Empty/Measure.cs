@@ -34,15 +34,19 @@ public sealed class Measure : IDisposable
 {
     private readonly IRainmeterMeasureApiProxy _rainmeterMeasure;
 
+    // use this to push new values from any thread instead of waiting for the next Update() call
+    private readonly IShimApiProxy _shim;
+
     private IntPtr _getStringBufferIntPtr;
     private IntPtr _customFunctionBufferIntPtr;
 
     /// <summary>
     /// Initializes a new instance of the <see cref="Measure"/> class.
     /// </summary>
-    public Measure(IRainmeterMeasureApiProxy rainmeterMeasure)
+    public Measure(IRainmeterMeasureApiProxy rainmeterMeasure, IShimApiProxy shim)
     {
         _rainmeterMeasure = rainmeterMeasure;
+        _shim = shim;
     }
 
     /// <inheritdoc cref="NativeInterop.Plugin.Update"/>
@@ -0,0 +1,54 @@
+﻿/* -----------------------------------------------------------------------
+    Copyright (C) 2023 whiskycompiler
+
+    This file is part of "Plugin.Example.Empty".
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+// ReSharper disable UnusedMemberInSuper.Global | reflects complete native API
+
+namespace Plugin.Example.Empty.NativeInterop;
+
+/// <summary>
+/// Proxy to access the API of the native shim that hosts the plugin.
+/// </summary>
+public interface IShimApiProxy
+{
+    /// <summary>
+    ///     Pushes a new value of the measure to the shim which asynchronously requests rainmeter to update the measure.
+    /// </summary>
+    /// <remarks>
+    ///     Can be called from any thread and never blocks. The pushed value is returned by the next update of the measure<br/>
+    ///     instead of calling <see cref="Plugin.Update"/> and <see cref="Plugin.GetString"/>.
+    ///     Bursts of pushed values are coalesced into a single update. Values pushed during <see cref="Plugin.Update"/><br/>
+    ///     are returned by that update. Values pushed after the measure was finalized and values of measures with<br/>
+    ///     "SharedUpdate=1" are ignored.
+    /// </remarks>
+    /// <param name="value">Number value of the measure.</param>
+    /// <param name="stringValue">String value of the measure or <see langword="null"/> to use the number value.</param>
+    public void Publish(double value, string? stringValue = null);
+
+    /// <summary>
+    ///     Sets a field of the record of the measure that is served to child measures ("Parent=" and "Field=" options).
+    /// </summary>
+    /// <remarks>
+    ///     Child measures are served by the shim without calling into the plugin. Field values are published to<br/>
+    ///     the child measures after <see cref="Plugin.Update"/> returned or a value was pushed with <see cref="Publish"/>.
+    /// </remarks>
+    /// <param name="field">Case sensitive name of the field.</param>
+    /// <param name="value">Number value of the field.</param>
+    /// <param name="stringValue">String value of the field or <see langword="null"/> to use the number value.</param>
+    public void SetField(string field, double value, string? stringValue = null);
+}
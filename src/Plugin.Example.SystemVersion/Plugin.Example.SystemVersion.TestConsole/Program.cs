@@ -23,7 +23,7 @@ using ExamplePlugin = Plugin.Example.SystemVersion.NativeInterop.Plugin;
 var data = IntPtr.Zero;
 var maxValue = 0d;
 
-ExamplePlugin.Initialize(ref data, IntPtr.Zero);
+ExamplePlugin.Initialize(ref data, IntPtr.Zero, IntPtr.Zero);
 
 Console.WriteLine(ExamplePlugin.Update(data));
 await Task.Delay(1000);
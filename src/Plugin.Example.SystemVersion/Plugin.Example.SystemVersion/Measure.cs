@@ -43,20 +43,30 @@ namespace Plugin.Example.SystemVersion
 
         private readonly IRainmeterMeasureApiProxy _rainmeterMeasure;
 
+        // use this to push new values from any thread instead of waiting for the next Update() call
+        private readonly IShimApiProxy _shim;
+
         private IntPtr _getStringBufferIntPtr;
         private MeasureType _measureType = MeasureType.String;
 
         /// <summary>
         /// Initializes a new instance of the <see cref="Measure"/> class.
         /// </summary>
-        public Measure(IRainmeterMeasureApiProxy rainmeterMeasure)
+        public Measure(IRainmeterMeasureApiProxy rainmeterMeasure, IShimApiProxy shim)
         {
             _rainmeterMeasure = rainmeterMeasure;
+            _shim = shim;
         }
 
         /// <inheritdoc cref="NativeInterop.Plugin.Update"/>
         public double Update()
         {
+            // fields can be read by child measures without calling into the plugin (see skin example)
+            var version = Environment.OSVersion.Version;
+            _shim.SetField("Major", version.Major);
+            _shim.SetField("Minor", version.Minor);
+            _shim.SetField("Build", version.Build);
+
             switch (_measureType)
             {
                 case MeasureType.Major:
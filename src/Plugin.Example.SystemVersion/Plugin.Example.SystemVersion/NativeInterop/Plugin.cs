@@ -35,7 +35,7 @@ namespace Plugin.Example.SystemVersion.NativeInterop;
 public static class Plugin
 {
     #region Delegates for native callers used by hostfxr
-    public delegate void InitializeDelegate(ref IntPtr measureData, IntPtr rainmeter);
+    public delegate void InitializeDelegate(ref IntPtr measureData, IntPtr rainmeter, IntPtr shimCallbacks);
     public delegate double UpdateDelegate(IntPtr measureData);
     public delegate void ReloadDelegate(IntPtr measureData, IntPtr rainmeter, ref double maxValue);
     public delegate void FinalizeDelegate(IntPtr measureData);
@@ -57,24 +57,37 @@ public static class Plugin
     /// <param name="measureApiPointer">
     ///     Pointer to interact with rainmeter in the name of your measure.
     /// </param>
-    public static void Initialize(ref IntPtr measurePointer, IntPtr measureApiPointer)
+    /// <param name="shimApiPointer">
+    ///     Pointer to the callbacks of the native shim (e.g. to push new values of your measure).
+    /// </param>
+    public static void Initialize(ref IntPtr measurePointer, IntPtr measureApiPointer, IntPtr shimApiPointer)
     {
         IRainmeterMeasureApiProxy? measureApiProxy = measureApiPointer == IntPtr.Zero
             ? null
             : new RainmeterMeasureApiProxy(measureApiPointer);
 
+        IShimApiProxy? shimApiProxy = shimApiPointer == IntPtr.Zero
+            ? null
+            : new ShimApiProxy(shimApiPointer);
+
 #if DEBUG
         measureApiProxy ??= new MeasureApiTestProxy();
+        shimApiProxy ??= new ShimApiTestProxy();
 #else
         if (measureApiProxy == null)
         {
             throw new ArgumentNullException(nameof(measureApiPointer));
         }
+
+        if (shimApiProxy == null)
+        {
+            throw new ArgumentNullException(nameof(shimApiPointer));
+        }
 #endif
 
         try
         {
-            var measure = new Measure(measureApiProxy);
+            var measure = new Measure(measureApiProxy, shimApiProxy);
             measurePointer = GCHandle.ToIntPtr(GCHandle.Alloc(measure));
         }
         catch (Exception e)
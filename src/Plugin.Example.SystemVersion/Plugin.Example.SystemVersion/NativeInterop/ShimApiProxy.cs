@@ -0,0 +1,77 @@
+﻿/* -----------------------------------------------------------------------
+    Copyright (C) 2023 whiskycompiler
+
+    This file is part of "Plugin.Example.SystemVersion".
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+using System.Runtime.InteropServices;
+
+namespace Plugin.Example.SystemVersion.NativeInterop;
+
+/// <inheritdoc cref="IShimApiProxy"/>
+public class ShimApiProxy : IShimApiProxy
+{
+    private readonly IntPtr _context;
+    private readonly PublishDelegate _publish;
+    private readonly SetFieldDelegate _setField;
+
+    /// <summary>
+    /// Initializes a new instance of the <see cref="ShimApiProxy"/> class.
+    /// </summary>
+    public ShimApiProxy(IntPtr shimCallbacksPointer)
+    {
+        var callbacks = Marshal.PtrToStructure<ShimCallbacks>(shimCallbacksPointer);
+        _context = callbacks.Context;
+        _publish = Marshal.GetDelegateForFunctionPointer<PublishDelegate>(callbacks.Publish);
+        _setField = Marshal.GetDelegateForFunctionPointer<SetFieldDelegate>(callbacks.SetField);
+    }
+
+    /// <inheritdoc/>
+    public void Publish(double value, string? stringValue = null)
+    {
+        _publish(_context, value, stringValue);
+    }
+
+    /// <inheritdoc/>
+    public void SetField(string field, double value, string? stringValue = null)
+    {
+        _setField(_context, field, value, stringValue);
+    }
+
+    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+    private delegate void PublishDelegate(
+        IntPtr context,
+        double value,
+        [MarshalAs(UnmanagedType.LPWStr)] string? stringValue);
+
+    [UnmanagedFunctionPointer(CallingConvention.StdCall)]
+    private delegate void SetFieldDelegate(
+        IntPtr context,
+        [MarshalAs(UnmanagedType.LPWStr)] string field,
+        double value,
+        [MarshalAs(UnmanagedType.LPWStr)] string? stringValue);
+
+    /// <summary>
+    /// Callbacks provided by the shim - layout must match "ShimCallbacks" in MeasureShim.hpp.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    private struct ShimCallbacks
+    {
+        public IntPtr Context;
+        public IntPtr Publish;
+        public IntPtr SetField;
+    }
+}
@@ -0,0 +1,40 @@
+﻿/* -----------------------------------------------------------------------
+    Copyright (C) 2023 whiskycompiler
+
+    This file is part of "Plugin.Example.SystemVersion".
+
+    This program is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation, either version 3
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+    See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+namespace Plugin.Example.SystemVersion.NativeInterop;
+
+/// <summary>
+/// Test proxy that logs all shim API calls to the console.
+/// Useful when testing stuff with e.g. a C# console app.
+/// </summary>
+public class ShimApiTestProxy : IShimApiProxy
+{
+    /// <inheritdoc/>
+    public void Publish(double value, string? stringValue = null)
+    {
+        Console.WriteLine($"Called Publish(\n\tvalue: '{value}',\n\tstringValue: '{stringValue}')");
+    }
+
+    /// <inheritdoc/>
+    public void SetField(string field, double value, string? stringValue = null)
+    {
+        Console.WriteLine(
+            $"Called SetField(\n\tfield: '{field}',\n\tvalue: '{value}',\n\tstringValue: '{stringValue}')");
+    }
+}
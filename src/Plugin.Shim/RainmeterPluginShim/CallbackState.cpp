@@ -0,0 +1,223 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#include "CallbackState.hpp"
+
+#include <format>
+
+constexpr auto WM_SHIM_UPDATE_REQUEST = WM_APP + 1;
+constexpr auto REQUEST_WINDOW_CLASS = L"RainmeterPluginShimUpdateRequests";
+
+std::shared_mutex CallbackState::statesMutex;
+std::unordered_map<uint32_t, std::shared_ptr<CallbackState>> CallbackState::states;
+std::atomic<DWORD> CallbackState::mainThreadId = 0;
+std::atomic<HWND> CallbackState::window = nullptr;
+
+namespace
+{
+	HINSTANCE GetShimModule()
+	{
+		HMODULE module = nullptr;
+		GetModuleHandleExW(
+			GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			reinterpret_cast<LPCWSTR>(&GetShimModule),
+			&module);
+		return module;
+	}
+}
+
+CallbackState::CallbackState(const uint32_t id, void* skin, string_t measureName)
+	: id(id)
+	, skin(skin)
+	, measureName(std::move(measureName))
+	, updateCommand(std::format(L"[!UpdateMeasure \"{}\"]", this->measureName))
+{
+}
+
+CallbackState::~CallbackState()
+{
+	delete pendingPush.exchange(nullptr);
+}
+
+std::shared_ptr<CallbackState> CallbackState::Open(const uint32_t id, void* skin, const LPCWSTR measureName)
+{
+	mainThreadId = GetCurrentThreadId();
+	if (window.load() == nullptr)
+	{
+		CreateRequestWindow();
+	}
+
+	auto state = std::make_shared<CallbackState>(id, skin, measureName != nullptr ? measureName : L"");
+
+	const std::unique_lock lock(statesMutex);
+	states[id] = state;
+	return state;
+}
+
+std::shared_ptr<CallbackState> CallbackState::Find(const uint32_t id)
+{
+	const std::shared_lock lock(statesMutex);
+	const auto state = states.find(id);
+	return state != states.end() ? state->second : nullptr;
+}
+
+void CallbackState::Close()
+{
+	closed.store(true);
+
+	bool isLast;
+	{
+		const std::unique_lock lock(statesMutex);
+		states.erase(id);
+		isLast = states.empty();
+	}
+
+	// Requests that are still queued for the window are discarded with it
+	if (isLast)
+	{
+		DestroyRequestWindow();
+	}
+}
+
+void CallbackState::Push(const double value, const LPCWSTR stringValue)
+{
+	if (closed.load())
+	{
+		return;
+	}
+
+	if (rejectPushes.load())
+	{
+		rejectedPush.store(true);
+		return;
+	}
+
+	// Replace the pending value without locking - a value that was not picked up yet is outdated anyway
+	delete pendingPush.exchange(new PushedValue{ value, stringValue != nullptr, stringValue != nullptr ? stringValue : L"" });
+
+	// The update of the measure that is running right now returns the value anyway
+	if (updating && GetCurrentThreadId() == mainThreadId)
+	{
+		return;
+	}
+
+	// Posting never blocks and the request is handled after the current call into the plugin returned,
+	// so pushes on the main thread (e.g. from ExecuteBang) cannot re-enter the measure
+	if (!updateRequested.exchange(true))
+	{
+		const auto target = window.load();
+		if (target == nullptr || PostMessageW(target, WM_SHIM_UPDATE_REQUEST, id, 0) == FALSE)
+		{
+			updateRequested.store(false);
+		}
+	}
+}
+
+std::unique_ptr<PushedValue> CallbackState::TakePush()
+{
+	// Clear the request first so later pushes request a new update
+	updateRequested.store(false);
+	return std::unique_ptr<PushedValue>(pendingPush.exchange(nullptr));
+}
+
+void CallbackState::SetUpdating(const bool value)
+{
+	updating = value;
+}
+
+void CallbackState::SetRejectPushes(const bool value)
+{
+	rejectPushes.store(value);
+	if (value)
+	{
+		TakePush();
+	}
+}
+
+bool CallbackState::ReportRejectedPush()
+{
+	if (rejectedPushReported || !rejectedPush.load())
+	{
+		return false;
+	}
+
+	rejectedPushReported = true;
+	return true;
+}
+
+
+std::shared_ptr<MeasureRecord> CallbackState::GetRecord()
+{
+	const std::lock_guard lock(recordMutex);
+	return record;
+}
+
+std::shared_ptr<MeasureRecord> CallbackState::GetOrCreateRecord()
+{
+	const std::lock_guard lock(recordMutex);
+
+	// Only parent measures set fields so other measures never get a record
+	if (record == nullptr && skin != nullptr && !measureName.empty())
+	{
+		record = MeasureRecord::Get(skin, measureName);
+	}
+
+	return record;
+}
+
+void CallbackState::CreateRequestWindow()
+{
+	const auto module = GetShimModule();
+
+	WNDCLASSEXW windowClass{};
+	windowClass.cbSize = sizeof windowClass;
+	windowClass.lpfnWndProc = &RequestWindowProc;
+	windowClass.hInstance = module;
+	windowClass.lpszClassName = REQUEST_WINDOW_CLASS;
+	RegisterClassExW(&windowClass);
+
+	window.store(CreateWindowExW(0, REQUEST_WINDOW_CLASS, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr, module, nullptr));
+}
+
+void CallbackState::DestroyRequestWindow()
+{
+	const auto target = window.exchange(nullptr);
+	if (target != nullptr)
+	{
+		DestroyWindow(target);
+		UnregisterClassW(REQUEST_WINDOW_CLASS, GetShimModule());
+	}
+}
+
+LRESULT CALLBACK CallbackState::RequestWindowProc(const HWND hwnd, const UINT message, const WPARAM wParam, const LPARAM lParam)
+{
+	if (message != WM_SHIM_UPDATE_REQUEST)
+	{
+		return DefWindowProcW(hwnd, message, wParam, lParam);
+	}
+
+	// Runs on the main thread so the measure and its skin cannot be finalized concurrently
+	const auto state = Find(static_cast<uint32_t>(wParam));
+	if (state != nullptr && !state->closed.load() && state->skin != nullptr)
+	{
+		RmExecute(state->skin, state->updateCommand.c_str());
+	}
+
+	return 0;
+}
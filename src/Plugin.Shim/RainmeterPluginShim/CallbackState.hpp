@@ -0,0 +1,122 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "include.hpp"
+#include "MeasureRecord.hpp"
+
+// Value pushed by the dotnet plugin
+struct PushedValue
+{
+	double value;
+	bool hasString;
+	string_t stringValue;
+};
+
+// State of a measure the callbacks of the dotnet plugin operate on.
+// Callbacks look it up by the id of the measure so calls after the measure was finalized are safe no-ops.
+class CallbackState
+{
+public:
+	CallbackState(uint32_t id, void* skin, string_t measureName);
+	~CallbackState();
+
+	CallbackState(const CallbackState&) = delete;
+	CallbackState& operator=(const CallbackState&) = delete;
+
+	// Registers the state of a measure - rainmeter main thread only
+	static std::shared_ptr<CallbackState> Open(uint32_t id, void* skin, LPCWSTR measureName);
+
+	// Gets the state of the measure or nullptr if it is not open (anymore) - any thread
+	static std::shared_ptr<CallbackState> Find(uint32_t id);
+
+	// Unregisters the state so all following callbacks are ignored - rainmeter main thread only
+	void Close();
+
+	// Replaces the pending pushed value and requests an update of the measure - any thread
+	void Push(double value, LPCWSTR stringValue);
+
+	// Takes the pending pushed value or nullptr if nothing was pushed - rainmeter main thread only
+	std::unique_ptr<PushedValue> TakePush();
+
+	// Marks the update of the measure as running so pushes during it do not request another update - rainmeter main thread only
+	void SetUpdating(bool value);
+
+	// Drops all pushes while enabled (e.g. for measures in shared update mode) - rainmeter main thread only
+	void SetRejectPushes(bool value);
+
+	// Returns true once if a push was dropped - rainmeter main thread only
+	bool ReportRejectedPush();
+
+	// Record of the measure for its child measures or nullptr if no field was set yet - any thread
+	std::shared_ptr<MeasureRecord> GetRecord();
+
+	// Gets the record and creates it when the first field is set - any thread
+	std::shared_ptr<MeasureRecord> GetOrCreateRecord();
+
+private:
+	const uint32_t id;
+
+	// Skin and name of the measure
+	void* const skin;
+	const string_t measureName;
+
+	// Bang used to request an update of the measure
+	const string_t updateCommand;
+
+	std::atomic<bool> closed = false;
+
+	// Latest value pushed by the dotnet plugin that has not been returned by Update yet
+	std::atomic<PushedValue*> pendingPush = nullptr;
+
+	// Whether an update was already requested for pushed values - coalesces bursts of pushes
+	std::atomic<bool> updateRequested = false;
+
+	// Whether the dotnet plugin is updating the measure - only accessed from the rainmeter main thread
+	bool updating = false;
+
+	std::atomic<bool> rejectPushes = false;
+	std::atomic<bool> rejectedPush = false;
+	bool rejectedPushReported = false;
+
+	std::mutex recordMutex;
+	std::shared_ptr<MeasureRecord> record;
+
+	// Open states of all measures by id
+	static std::shared_mutex statesMutex;
+	static std::unordered_map<uint32_t, std::shared_ptr<CallbackState>> states;
+
+	// Thread that calls the plugin exports (i.e. the rainmeter main thread)
+	static std::atomic<DWORD> mainThreadId;
+
+	// Message-only window on the main thread that receives update requests of other threads.
+	// Posting to it never blocks so threads pushing values cannot deadlock with the main thread.
+	static std::atomic<HWND> window;
+
+	static void CreateRequestWindow();
+	static void DestroyRequestWindow();
+	static LRESULT CALLBACK RequestWindowProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
+};
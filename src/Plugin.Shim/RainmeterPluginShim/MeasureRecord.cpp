@@ -0,0 +1,92 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#include "MeasureRecord.hpp"
+
+#include <algorithm>
+#include <cwctype>
+
+std::map<std::pair<void*, string_t>, std::weak_ptr<MeasureRecord>> MeasureRecord::records;
+std::mutex MeasureRecord::recordsMutex;
+
+std::shared_ptr<MeasureRecord> MeasureRecord::Get(void* skin, const string_t& measureName)
+{
+	// Measure names are case insensitive in rainmeter
+	string_t name = measureName;
+	std::transform(name.begin(), name.end(), name.begin(), std::towlower);
+
+	std::pair<void*, string_t> key{ skin, std::move(name) };
+
+	const std::lock_guard lock(recordsMutex);
+	auto& entry = records[key];
+	auto record = entry.lock();
+	if (record == nullptr)
+	{
+		record = std::make_shared<MeasureRecord>(std::move(key));
+		entry = record;
+	}
+
+	return record;
+}
+
+MeasureRecord::MeasureRecord(std::pair<void*, string_t> key)
+	: key(std::move(key))
+{
+}
+
+MeasureRecord::~MeasureRecord()
+{
+	// The entry may already belong to a new record of the same measure
+	const std::lock_guard lock(recordsMutex);
+	const auto entry = records.find(key);
+	if (entry != records.end() && entry->second.expired())
+	{
+		records.erase(entry);
+	}
+}
+
+void MeasureRecord::SetField(const string_t& name, const double value, const LPCWSTR stringValue)
+{
+	const std::lock_guard lock(stagedFieldsMutex);
+	stagedFields[name] = RecordField{ value, stringValue != nullptr, stringValue != nullptr ? stringValue : L"" };
+}
+
+void MeasureRecord::Commit()
+{
+	const std::lock_guard lock(stagedFieldsMutex);
+	if (stagedFields.empty())
+	{
+		return;
+	}
+
+	// Assign instead of replacing the nodes so pointers held by child measures stay valid
+	for (auto& [name, field] : stagedFields)
+	{
+		fields[name] = std::move(field);
+	}
+
+	stagedFields.clear();
+	++version;
+}
+
+const RecordField* MeasureRecord::GetField(const string_t& name) const
+{
+	const auto field = fields.find(name);
+	return field != fields.end() ? &field->second : nullptr;
+}
@@ -0,0 +1,79 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#include "include.hpp"
+
+// Field of a measure record
+struct RecordField
+{
+	double value;
+	bool hasString;
+	string_t stringValue;
+};
+
+// Record of typed fields filled by a parent measure and read by its child measures in native code
+class MeasureRecord
+{
+public:
+	// Gets the record of the measure in the given skin - the record is created if it does not exist yet
+	static std::shared_ptr<MeasureRecord> Get(void* skin, const string_t& measureName);
+
+	explicit MeasureRecord(std::pair<void*, string_t> key);
+	~MeasureRecord();
+
+	MeasureRecord(const MeasureRecord&) = delete;
+	MeasureRecord& operator=(const MeasureRecord&) = delete;
+
+	// Stages a field value - can be called from any thread
+	void SetField(const string_t& name, double value, LPCWSTR stringValue);
+
+	// Publishes all staged field values to the child measures - rainmeter main thread only
+	void Commit();
+
+	// Gets the published field or nullptr if the field was never set - rainmeter main thread only
+	// The returned pointer stays valid for the lifetime of the record.
+	[[nodiscard]] const RecordField* GetField(const string_t& name) const;
+
+	// Incremented whenever staged field values are published
+	[[nodiscard]] unsigned long long GetVersion() const { return version; }
+
+private:
+	// Field values published to the child measures
+	std::unordered_map<string_t, RecordField> fields;
+
+	// Field values set by the dotnet plugin since the last commit
+	std::unordered_map<string_t, RecordField> stagedFields;
+	std::mutex stagedFieldsMutex;
+
+	unsigned long long version = 0;
+
+	// Skin and lowercase measure name the record is registered with
+	const std::pair<void*, string_t> key;
+
+	// Records of parent measures and measures referenced as parents by skin and measure name
+	static std::map<std::pair<void*, string_t>, std::weak_ptr<MeasureRecord>> records;
+	static std::mutex recordsMutex;
+};
@@ -20,13 +20,21 @@
 #include "MeasureShim.hpp"
 
 #include <format>
+#include <string_view>
 
-Measure::Measure(string_t binaryPath, string_t runtimeConfigPath, string_t dotnetPluginType)
-	: binaryPath(std::move(binaryPath))
+std::atomic<uint32_t> Measure::nextId = 1;
+
+Measure::Measure(
+	string_t binaryPath,
+	string_t runtimeConfigPath,
+	string_t dotnetPluginType,
+	StartupCache* startupCache)
+	: id(nextId++)
+	, binaryPath(std::move(binaryPath))
 	, runtimeConfigPath(std::move(runtimeConfigPath))
 	, dotnetPluginType(std::move(dotnetPluginType))
 {
-	netHost = new NetHost;
+	netHost = new NetHost(startupCache);
 }
 
 Measure::~Measure()
@@ -45,13 +53,52 @@ Measure::~Measure()
 void Measure::Initialize(void* rm)
 {
 	this->rainmeter = rm;
+	skin = rainmeter != nullptr ? RmGetSkin(rainmeter) : nullptr;
+	callbackState = CallbackState::Open(id, skin, rainmeter != nullptr ? RmGetMeasureName(rainmeter) : nullptr);
+	if (rainmeter != nullptr)
+	{
+		// Child measures are served from the record of their parent and never call into the dotnet plugin
+		ReadChildOptions();
+		if (parentRecord != nullptr)
+		{
+			return;
+		}
+	}
+
+	InitializeUpdateMode();
+}
+
+void Measure::InitializeUpdateMode()
+{
+	if (rainmeter != nullptr && RmReadInt(rainmeter, L"SharedUpdate", 0) != 0)
+	{
+		sharedKey = SharedMeasureGroup::BuildKey(rainmeter);
+		if (!sharedKey.empty())
+		{
+			JoinSharedGroup();
+			return;
+		}
+
+		RmLog(rainmeter, LOG_WARNING, L"SharedUpdate requires SharedOptions! The measure is updated on its own.");
+	}
+
+	InitializeManaged();
+}
+
+void Measure::InitializeManaged()
+{
+	TraceScope trace(id, TraceEntryPoint::Initialize);
 	if (EnsureInitializedNetMethodPointer(L"Initialize", L"InitializeDelegate", reinterpret_cast<void**>(&initialize)))
 	{
-		initialize(&data, rainmeter);
+		initialize(&data, rainmeter, &callbacks);
 		if (data == nullptr)
 		{
 			RmLog(rainmeter, LOG_ERROR, L"Measure initialization failed! Shim received nullptr from .NET plugin.");
 		}
+		else
+		{
+			trace.SetSucceeded();
+		}
 	}
 	else
 	{
@@ -61,11 +108,52 @@ void Measure::Initialize(void* rm)
 
 double Measure::Update()
 {
+	if (parentRecord != nullptr)
+	{
+		const auto field = GetParentRecordField();
+		return field != nullptr ? field->value : 0.0;
+	}
+
+	if (sharedGroup != nullptr)
+	{
+		return UpdateShared();
+	}
+
+	return UpdateManaged();
+}
+
+double Measure::UpdateManaged()
+{
+	// Pushed values replace the regular update
+	pushedValue = callbackState != nullptr ? callbackState->TakePush() : nullptr;
+	if (pushedValue != nullptr)
+	{
+		CommitRecord();
+		return pushedValue->value;
+	}
+
+	TraceScope trace(id, TraceEntryPoint::Update);
 	if (EnsureInitializedNetMethodPointer(L"Update", L"UpdateDelegate", reinterpret_cast<void**>(&update)))
 	{
 		if (data != nullptr)
 		{
-			return update(data);
+			if (callbackState != nullptr)
+			{
+				callbackState->SetUpdating(true);
+			}
+
+			const auto value = update(data);
+			trace.SetSucceeded();
+
+			// Values pushed during the update are newer than the updated value
+			if (callbackState != nullptr)
+			{
+				callbackState->SetUpdating(false);
+				pushedValue = callbackState->TakePush();
+			}
+
+			CommitRecord();
+			return pushedValue != nullptr ? pushedValue->value : value;
 		}
 
 		RmLog(rainmeter, LOG_WARNING, L"Update was not executed because the Measure is not properly initialized!");
@@ -80,11 +168,48 @@ double Measure::Update()
 
 void Measure::Finalize()
 {
+	if (parentRecord != nullptr)
+	{
+		parentRecord = nullptr;
+		parentRecordField = nullptr;
+	}
+	else if (sharedGroup != nullptr)
+	{
+		LeaveSharedGroup();
+	}
+	else
+	{
+		FinalizeManaged();
+	}
+
+	// Callbacks of the dotnet plugin are ignored from now on
+	if (callbackState != nullptr)
+	{
+		callbackState->Close();
+		callbackState = nullptr;
+	}
+
+	rainmeter = nullptr;
+	data = nullptr;
+}
+
+void Measure::FinalizeManaged()
+{
+	TraceScope trace(id, TraceEntryPoint::Finalize);
 	if (EnsureInitializedNetMethodPointer(L"Finalize", L"FinalizeDelegate", reinterpret_cast<void**>(&finalize)))
 	{
 		if (data != nullptr)
 		{
 			finalize(data);
+			trace.SetSucceeded();
+
+			// Values pushed by the finalized dotnet plugin instance are outdated
+			if (callbackState != nullptr)
+			{
+				callbackState->TakePush();
+			}
+
+			pushedValue = nullptr;
 		}
 		else
 		{
@@ -96,18 +221,76 @@ void Measure::Finalize()
 		RmLog(rainmeter, LOG_ERROR, L"Shim failed to get pointer to the Finalize method of the C# plugin!");
 	}
 
-	rainmeter = nullptr;
 	data = nullptr;
 }
 
 void Measure::Reload(void* rm, double* maxValue)
 {
 	rainmeter = rm;
+	if (parentRecord != nullptr)
+	{
+		// Parent and field may have changed if "DynamicVariables=1"
+		ReadChildOptions();
+		if (parentRecord != nullptr)
+		{
+			return;
+		}
+
+		// The measure is no child anymore and is updated by the dotnet plugin from now on
+		InitializeUpdateMode();
+	}
+
+	if (sharedGroup != nullptr)
+	{
+		// Options may have changed if "DynamicVariables=1" so the measure might belong to another group now
+		auto key = SharedMeasureGroup::BuildKey(rainmeter);
+		if (key.empty())
+		{
+			RmLog(rainmeter, LOG_WARNING, L"SharedUpdate requires SharedOptions! The measure is updated on its own.");
+			LeaveSharedGroup();
+			sharedKey.clear();
+			InitializeManaged();
+			ReloadManaged(maxValue);
+			return;
+		}
+
+		if (key != sharedKey)
+		{
+			LeaveSharedGroup();
+			sharedKey = std::move(key);
+			JoinSharedGroup();
+		}
+
+		if (sharedGroup->GetHost() == this && sharedGroup->isHostStarted)
+		{
+			ReloadManaged(maxValue);
+			sharedGroup->maxValue = *maxValue;
+		}
+		else if (sharedGroup->GetHost() == this)
+		{
+			StartSharedHost();
+			*maxValue = sharedGroup->maxValue;
+		}
+		else
+		{
+			*maxValue = sharedGroup->maxValue;
+		}
+
+		return;
+	}
+
+	ReloadManaged(maxValue);
+}
+
+void Measure::ReloadManaged(double* maxValue)
+{
+	TraceScope trace(id, TraceEntryPoint::Reload);
 	if (EnsureInitializedNetMethodPointer(L"Reload", L"ReloadDelegate", reinterpret_cast<void**>(&reload)))
 	{
 		if (data != nullptr)
 		{
 			reload(data, rainmeter, maxValue);
+			trace.SetSucceeded();
 		}
 		else
 		{
@@ -122,11 +305,35 @@ void Measure::Reload(void* rm, double* maxValue)
 
 LPCWSTR Measure::GetString()
 {
+	if (parentRecord != nullptr)
+	{
+		const auto field = parentRecordField;
+		return field != nullptr && field->hasString ? field->stringValue.c_str() : nullptr;
+	}
+
+	if (sharedGroup != nullptr)
+	{
+		return sharedGroup->hasString ? sharedGroup->stringValue.c_str() : nullptr;
+	}
+
+	return GetStringManaged();
+}
+
+LPCWSTR Measure::GetStringManaged()
+{
+	if (pushedValue != nullptr)
+	{
+		return pushedValue->hasString ? pushedValue->stringValue.c_str() : nullptr;
+	}
+
+	TraceScope trace(id, TraceEntryPoint::GetString);
 	if (EnsureInitializedNetMethodPointer(L"GetString", L"GetStringDelegate", reinterpret_cast<void**>(&getString)))
 	{
 		if (data != nullptr)
 		{
-			return getString(data);
+			const auto value = getString(data);
+			trace.SetSucceeded();
+			return value;
 		}
 
 		RmLog(rainmeter, LOG_WARNING, L"GetString was not executed because the Measure is not properly initialized!");
@@ -141,11 +348,35 @@ LPCWSTR Measure::GetString()
 
 void Measure::ExecuteBang(const LPCWSTR args)
 {
+	if (ExecuteTraceBang(args))
+	{
+		return;
+	}
+
+	if (parentRecord != nullptr)
+	{
+		RmLog(rainmeter, LOG_WARNING, L"ExecuteBang is not supported by child measures!");
+		return;
+	}
+
+	if (sharedGroup != nullptr && sharedGroup->GetHost() != this)
+	{
+		StartSharedHost()->ExecuteBang(args);
+		return;
+	}
+
+	if (sharedGroup != nullptr)
+	{
+		StartSharedHost();
+	}
+
+	TraceScope trace(id, TraceEntryPoint::ExecuteBang);
 	if (EnsureInitializedNetMethodPointer(L"ExecuteBang", L"ExecuteBangDelegate", reinterpret_cast<void**>(&executeBang)))
 	{
 		if (data != nullptr)
 		{
 			executeBang(data, args);
+			trace.SetSucceeded();
 		}
 		else
 		{
@@ -165,11 +396,31 @@ LPCWSTR Measure::CutomFunc(const int argc, const WCHAR* argv[])
 	// You just need to change the "entryPointName" parameter in the next line to the name of your own custom function
 	// in the C# plugin class and provide a new cache variable for the pointer (last parameter and following line).
 	// You can keep the "delegateName" as is if you want (signature of all functions is identical after all).
+	// Measures in shared update mode have to forward the call to the host of their group.
+	if (parentRecord != nullptr)
+	{
+		RmLog(rainmeter, LOG_WARNING, L"CustomFunc is not supported by child measures!");
+		return nullptr;
+	}
+
+	if (sharedGroup != nullptr && sharedGroup->GetHost() != this)
+	{
+		return StartSharedHost()->CutomFunc(argc, argv);
+	}
+
+	if (sharedGroup != nullptr)
+	{
+		StartSharedHost();
+	}
+
+	TraceScope trace(id, TraceEntryPoint::CustomFunc);
 	if (EnsureInitializedNetMethodPointer(L"CustomFunc", L"CustomFuncDelegate", reinterpret_cast<void**>(&customFunc)))
 	{
 		if (data != nullptr)
 		{
-			return customFunc(data, argc, argv);
+			const auto value = customFunc(data, argc, argv);
+			trace.SetSucceeded();
+			return value;
 		}
 
 		RmLog(rainmeter, LOG_WARNING, L"CustomFunc was not executed because the Measure is not properly initialized!");
@@ -179,6 +430,211 @@ LPCWSTR Measure::CutomFunc(const int argc, const WCHAR* argv[])
 	return nullptr;
 }
 
+void Measure::JoinSharedGroup()
+{
+	sharedGroup = SharedMeasureGroup::Join(sharedKey, this);
+	sharedGeneration = 0;
+
+	// Pushed values would only update the host so they are not supported in shared update mode
+	callbackState->SetRejectPushes(true);
+
+	// The first measure of a group hosts the .NET plugin instance for all of them
+	if (sharedGroup->GetHost() == this)
+	{
+		InitializeManaged();
+		sharedGroup->isHostStarted = true;
+	}
+}
+
+void Measure::LeaveSharedGroup()
+{
+	if (sharedGroup->GetHost() == this && sharedGroup->isHostStarted)
+	{
+		FinalizeManaged();
+	}
+
+	// The next measure only creates the .NET plugin instance on first use because it is
+	// often part of the same skin and about to be finalized as well
+	if (SharedMeasureGroup::Leave(sharedGroup, this) != nullptr)
+	{
+		sharedGroup->isHostStarted = false;
+	}
+
+	sharedGroup = nullptr;
+	callbackState->SetRejectPushes(false);
+}
+
+Measure* Measure::StartSharedHost()
+{
+	const auto host = sharedGroup->GetHost();
+	if (!sharedGroup->isHostStarted)
+	{
+		sharedGroup->isHostStarted = true;
+		host->InitializeManaged();
+		host->ReloadManaged(&sharedGroup->maxValue);
+	}
+
+	return host;
+}
+
+double Measure::UpdateShared()
+{
+	// A measure that already returned the current result starts the next update cycle of the group
+	// while all other measures just pick up the result.
+	if (sharedGeneration == sharedGroup->generation)
+	{
+		const auto host = StartSharedHost();
+		sharedGroup->value = host->UpdateManaged();
+
+		const auto value = host->GetStringManaged();
+		sharedGroup->hasString = value != nullptr;
+		sharedGroup->stringValue = value != nullptr ? value : L"";
+		++sharedGroup->generation;
+
+		if (host->callbackState->ReportRejectedPush())
+		{
+			RmLog(host->rainmeter, LOG_WARNING, L"Pushed values are ignored for measures with SharedUpdate=1!");
+		}
+	}
+
+	sharedGeneration = sharedGroup->generation;
+	return sharedGroup->value;
+}
+
+void CORECLR_DELEGATE_CALLTYPE Measure::Publish(void* context, const double value, const LPCWSTR stringValue)
+{
+	const auto state = CallbackState::Find(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(context)));
+	if (state != nullptr)
+	{
+		state->Push(value, stringValue);
+	}
+}
+
+void CORECLR_DELEGATE_CALLTYPE Measure::SetField(
+	void* context,
+	const LPCWSTR field,
+	const double value,
+	const LPCWSTR stringValue)
+{
+	const auto state = CallbackState::Find(static_cast<uint32_t>(reinterpret_cast<uintptr_t>(context)));
+	const auto record = state != nullptr ? state->GetOrCreateRecord() : nullptr;
+	if (record != nullptr && field != nullptr)
+	{
+		record->SetField(field, value, stringValue);
+	}
+}
+
+void Measure::CommitRecord() const
+{
+	const auto record = callbackState != nullptr ? callbackState->GetRecord() : nullptr;
+	if (record != nullptr)
+	{
+		record->Commit();
+	}
+}
+
+void Measure::ReadChildOptions()
+{
+	const string_t newParentName = RmReadString(rainmeter, L"Parent", L"");
+	const string_t fieldName = RmReadString(rainmeter, L"Field", L"");
+	if (newParentName.empty())
+	{
+		parentRecord = nullptr;
+		parentName.clear();
+		parentField.clear();
+		parentRecordField = nullptr;
+		parentRecordVersion = 0;
+		return;
+	}
+
+	auto newParentRecord = MeasureRecord::Get(skin, newParentName);
+	if (newParentRecord != parentRecord || fieldName != parentField)
+	{
+		parentRecord = std::move(newParentRecord);
+		parentName = newParentName;
+		parentField = fieldName;
+		parentRecordField = nullptr;
+		parentRecordVersion = 0;
+		missingFieldReported = false;
+
+		if (parentField.empty())
+		{
+			missingFieldReported = true;
+			RmLog(rainmeter, LOG_WARNING, L"Child measure requires Field! The measure always returns 0.");
+		}
+	}
+}
+
+const RecordField* Measure::GetParentRecordField()
+{
+	// Fields are never removed from a record so a found field only has to be looked up once
+	if (parentRecordField == nullptr && parentRecordVersion != parentRecord->GetVersion())
+	{
+		parentRecordVersion = parentRecord->GetVersion();
+		parentRecordField = parentRecord->GetField(parentField);
+
+		// The parent has published its fields at least once so the field or the parent name is probably misspelled
+		if (parentRecordField == nullptr && !missingFieldReported)
+		{
+			missingFieldReported = true;
+			RmLog(rainmeter, LOG_WARNING, std::format(
+				L"Parent measure '{}' did not set field '{}'! The measure returns 0 until it does.",
+				parentName,
+				parentField).c_str());
+		}
+	}
+
+	return parentRecordField;
+}
+
+bool Measure::ExecuteTraceBang(const LPCWSTR args) const
+{
+	// Usage: [!CommandMeasure "MeasureName" "ShimTrace Start|Stop|Dump [FilePath]"]
+	constexpr std::wstring_view prefix = L"ShimTrace";
+	const std::wstring_view bang = args != nullptr ? args : L"";
+	if (bang.size() < prefix.size() || _wcsnicmp(bang.data(), prefix.data(), prefix.size()) != 0
+		|| (bang.size() > prefix.size() && bang[prefix.size()] != L' '))
+	{
+		return false;
+	}
+
+	auto command = string_t(bang.substr(prefix.size()));
+	command.erase(0, command.find_first_not_of(L' '));
+	if (_wcsicmp(command.c_str(), L"Start") == 0)
+	{
+		Trace::SetEnabled(true);
+	}
+	else if (_wcsicmp(command.c_str(), L"Stop") == 0)
+	{
+		Trace::SetEnabled(false);
+	}
+	else if (_wcsnicmp(command.c_str(), L"Dump", 4) == 0)
+	{
+		auto filePath = command.substr(4);
+		filePath.erase(0, filePath.find_first_not_of(L' '));
+		if (filePath.empty())
+		{
+			filePath = string_t(PLUGIN_NAME_STRING) + L".shimtrace";
+		}
+
+		filePath = RmPathToAbsolute(rainmeter, filePath.c_str());
+		if (Trace::Dump(filePath))
+		{
+			RmLog(rainmeter, LOG_NOTICE, std::format(L"Shim trace written to '{}'.", filePath).c_str());
+		}
+		else
+		{
+			RmLog(rainmeter, LOG_ERROR, std::format(L"Failed to write shim trace to '{}'!", filePath).c_str());
+		}
+	}
+	else
+	{
+		RmLog(rainmeter, LOG_ERROR, std::format(L"Unknown ShimTrace command '{}'!", command).c_str());
+	}
+
+	return true;
+}
+
 bool Measure::EnsureInitializedNetMethodPointer(
 	const wchar_t* entryPointName,
 	const wchar_t* delegateName,
@@ -186,6 +642,8 @@ bool Measure::EnsureInitializedNetMethodPointer(
 {
 	if (*methodPointer == nullptr)
 	{
+		const auto startupDuration = NetHost::GetStartupDuration();
+
 		string_t* fullDelegateName;
 		GetFullDelegateName(delegateName, &fullDelegateName);
 		const auto result = netHost->GetMethodFromAssembly(
@@ -218,6 +676,15 @@ bool Measure::EnsureInitializedNetMethodPointer(
 
 			return false;
 		}
+
+		// The runtime is loaded once per process so only the first measure reports the startup time
+		if (startupDuration.count() == 0 && NetHost::GetStartupDuration().count() != 0)
+		{
+			RmLog(rainmeter, LOG_DEBUG, std::format(
+				L"Loading the .NET runtime took {} us ({}).",
+				NetHost::GetStartupDuration().count(),
+				NetHost::IsHostFxrFromStartupCache() ? L"hostfxr from startup cache" : L"startup cache missing or outdated, hostfxr discovered").c_str());
+		}
 	}
 
 	return true;
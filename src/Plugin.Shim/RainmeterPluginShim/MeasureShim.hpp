@@ -18,10 +18,29 @@
 --------------------------------------------------------------------------*/
 
 #pragma once
+#include <atomic>
+#include <memory>
+
 #include "include.hpp"
+#include "CallbackState.hpp"
+#include "MeasureRecord.hpp"
 #include "NetHost.hpp"
+#include "SharedMeasureGroup.hpp"
+#include "StartupCache.hpp"
+#include "Trace.hpp"
+
+typedef void (CORECLR_DELEGATE_CALLTYPE* shim_publish_fn)(void* context, double value, LPCWSTR stringValue);
+typedef void (CORECLR_DELEGATE_CALLTYPE* shim_set_field_fn)(void* context, LPCWSTR field, double value, LPCWSTR stringValue);
 
-typedef void (CORECLR_DELEGATE_CALLTYPE* dotnet_plugin_initialize_fn)(void** data, void* rainmeter);
+// Callbacks of the shim passed to the dotnet plugin on initialization - layout must match "ShimCallbacks" in ShimApiProxy.cs
+struct ShimCallbacks
+{
+	void* context;
+	shim_publish_fn publish;
+	shim_set_field_fn setField;
+};
+
+typedef void (CORECLR_DELEGATE_CALLTYPE* dotnet_plugin_initialize_fn)(void** data, void* rainmeter, const ShimCallbacks* callbacks);
 typedef double (CORECLR_DELEGATE_CALLTYPE* dotnet_plugin_update_fn)(void* data);
 typedef void (CORECLR_DELEGATE_CALLTYPE* dotnet_plugin_reload_fn)(void* data, void* rainmeter, double* maxValue);
 typedef LPCWSTR (CORECLR_DELEGATE_CALLTYPE* dotnet_plugin_get_string_fn)(void* data);
@@ -32,7 +51,7 @@ typedef void (CORECLR_DELEGATE_CALLTYPE* dotnet_plugin_finalize_fn)(void* data);
 class Measure
 {
 public:
-	Measure(string_t binaryPath, string_t runtimeConfigPath, string_t dotnetPluginType);
+	Measure(string_t binaryPath, string_t runtimeConfigPath, string_t dotnetPluginType, StartupCache* startupCache);
 	~Measure();
 
 	void Initialize(void* rm);
@@ -43,13 +62,37 @@ public:
 	void Finalize();
 	LPCWSTR CutomFunc(int argc, const WCHAR* argv[]);
 
+	// Called by the dotnet plugin from any thread to push a new value of the measure - the context is the measure id
+	static void CORECLR_DELEGATE_CALLTYPE Publish(void* context, double value, LPCWSTR stringValue);
+
+	// Called by the dotnet plugin to set a field of the record read by child measures
+	static void CORECLR_DELEGATE_CALLTYPE SetField(void* context, LPCWSTR field, double value, LPCWSTR stringValue);
+
 private:
+	// Source of the ids used to identify measures in traces
+	static std::atomic<uint32_t> nextId;
+
+	// Id of the measure in traces
+	const uint32_t id;
+
 	// Pointer to the rainmeter measure
 	void* rainmeter = nullptr;
 
 	// Data of the dotnet plugin that is held by the shim which is held by rainmeter
 	void* data = nullptr;
 
+	// Callbacks passed to the dotnet plugin
+	ShimCallbacks callbacks{ reinterpret_cast<void*>(static_cast<uintptr_t>(id)), &Measure::Publish, &Measure::SetField };
+
+	// State the callbacks operate on - closed when the measure is finalized
+	std::shared_ptr<CallbackState> callbackState;
+
+	// Skin of the measure
+	void* skin = nullptr;
+
+	// Pushed value returned by the last Update - only accessed from the rainmeter main thread
+	std::unique_ptr<PushedValue> pushedValue;
+
 	// Initialize method of the dotnet plugin
 	dotnet_plugin_initialize_fn initialize = nullptr;
 
@@ -83,6 +126,54 @@ private:
 	// Dotnet runtime host
 	NetHost* netHost;
 
+	// Group this measure shares the .NET plugin instance with or nullptr if sharing is disabled
+	std::shared_ptr<SharedMeasureGroup> sharedGroup;
+
+	// Last generation of the shared group result that was returned by this measure
+	unsigned long long sharedGeneration = 0;
+
+	// Fingerprint of the options that determined the shared group
+	string_t sharedKey;
+
+	void InitializeManaged();
+
+	// Starts the measure in shared update mode if configured and otherwise on its own
+	void InitializeUpdateMode();
+	double UpdateManaged();
+	void ReloadManaged(double* maxValue);
+	LPCWSTR GetStringManaged();
+	void FinalizeManaged();
+
+	// Shared update mode - see "SharedUpdate" option in the README.MD
+	void JoinSharedGroup();
+	void LeaveSharedGroup();
+	Measure* StartSharedHost();
+	double UpdateShared();
+
+	// Handles the "ShimTrace" bang - returns false if the bang is meant for the dotnet plugin
+	bool ExecuteTraceBang(LPCWSTR args) const;
+
+	// Record of the parent measure or nullptr if this is not a child measure
+	std::shared_ptr<MeasureRecord> parentRecord;
+
+	// Parent measure and field of the parent record served by this child measure
+	string_t parentName;
+	string_t parentField;
+
+	// Cached field of the parent record and the record version it was looked up in
+	const RecordField* parentRecordField = nullptr;
+	unsigned long long parentRecordVersion = 0;
+
+	// Whether a warning about the missing field was logged - misspelled options would fail silently otherwise
+	bool missingFieldReported = false;
+
+	// Publishes the fields set by the dotnet plugin to the child measures
+	void CommitRecord() const;
+
+	// Child measure mode - see "Parent" and "Field" options in the README.MD
+	void ReadChildOptions();
+	const RecordField* GetParentRecordField();
+
 	// Ensures that the pointer to the dotnet method is initialized - returns false on error
 	bool EnsureInitializedNetMethodPointer(const wchar_t* entryPointName, const wchar_t* delegateName, void** methodPointer) const;
 
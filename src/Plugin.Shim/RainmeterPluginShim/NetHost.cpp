@@ -18,15 +18,29 @@
 --------------------------------------------------------------------------*/
 
 #include <cassert>
+#include <vector>
 
 #include "NetHost.hpp"
 
+// Returned by get_hostfxr_path if the buffer is too small for the path
+constexpr auto HOST_API_BUFFER_TOO_SMALL = static_cast<int>(0x80008098);
+
+load_assembly_and_get_function_pointer_fn NetHost::get_function_pointer_fptr = nullptr;
+hostfxr_initialize_for_runtime_config_fn NetHost::init_fptr = nullptr;
+hostfxr_get_runtime_delegate_fn NetHost::get_delegate_fptr = nullptr;
+hostfxr_close_fn NetHost::close_fptr = nullptr;
+std::chrono::microseconds NetHost::startupDuration{ 0 };
+bool NetHost::hostFxrFromStartupCache = false;
+
+NetHost::NetHost(StartupCache* startupCache)
+	: startupCache(startupCache)
+{
+}
+
 NetHost::~NetHost()
 {
-	get_function_pointer_fptr = nullptr;
-	init_fptr = nullptr;
-	get_delegate_fptr = nullptr;
-	close_fptr = nullptr;
+	// hostfxr and the runtime stay loaded for the other measures
+	startupCache = nullptr;
 }
 
 int NetHost::GetMethodFromAssembly(
@@ -37,6 +51,9 @@ int NetHost::GetMethodFromAssembly(
 	const char_t* delegateName,
 	void** methodPointer)
 {
+	const bool isColdStart = !IsHostFxrLoaded() || get_function_pointer_fptr == nullptr;
+	const auto startTime = std::chrono::steady_clock::now();
+
 	// STEP 1: Load HostFxr and get exported hosting functions
 	if (!IsHostFxrLoaded())
 	{
@@ -55,6 +72,12 @@ int NetHost::GetMethodFromAssembly(
 		return result;
 	}
 
+	if (isColdStart)
+	{
+		startupDuration = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - startTime);
+	}
+
 	// STEP 3: Load managed assembly and get function pointer to a managed method
 	result = loadAssemblyAndGetFunctionPointer(
 		binaryPath,
@@ -75,16 +98,43 @@ int NetHost::GetMethodFromAssembly(
 // Using the nethost library, discover the location of hostfxr and get exports
 int NetHost::LoadHostFxr()
 {
-	// Pre-allocate a large buffer for the path to hostfxr
-	char_t buffer[MAX_PATH];
-	size_t buffer_size = sizeof buffer / sizeof(char_t);
-	if (get_hostfxr_path(buffer, &buffer_size, nullptr) != 0)
+	// Probing all install locations is expensive so try the location from the last start first.
+	// The cache is validated here so its cost is part of the measured startup duration.
+	if (startupCache != nullptr && startupCache->Load()
+		&& LoadHostFxr(startupCache->GetHostFxrPath().c_str()) == NETHOST_SUCCESS)
+	{
+		hostFxrFromStartupCache = true;
+		return NETHOST_SUCCESS;
+	}
+
+	// Pre-allocate a large buffer for the path to hostfxr and grow it if necessary
+	std::vector<char_t> buffer(MAX_PATH);
+	size_t buffer_size = buffer.size();
+	auto result = get_hostfxr_path(buffer.data(), &buffer_size, nullptr);
+	if (result == HOST_API_BUFFER_TOO_SMALL)
+	{
+		buffer.resize(buffer_size);
+		result = get_hostfxr_path(buffer.data(), &buffer_size, nullptr);
+	}
+
+	if (result != 0)
 	{
 		return NETHOST_ERROR_GET_HOSTFXR_PATH;
 	}
 
+	result = LoadHostFxr(buffer.data());
+	if (result == NETHOST_SUCCESS && startupCache != nullptr)
+	{
+		startupCache->SetHostFxrPath(buffer.data());
+	}
+
+	return result;
+}
+
+int NetHost::LoadHostFxr(const char_t* path)
+{
 	// Load hostfxr and get desired exports
-	const HMODULE lib = LoadLibraryW(buffer);
+	const HMODULE lib = LoadLibraryW(path);
 	if(lib == nullptr)
 	{
 		return NETHOST_ERROR_LOAD_HOSTFXR;
@@ -133,7 +183,7 @@ int NetHost::GetAssemblyFunctionLoader(
 	return NETHOST_ERROR_GET_RUNTIME_DELEGATE;
 }
 
-bool NetHost::IsHostFxrLoaded() const
+bool NetHost::IsHostFxrLoaded()
 {
 	return init_fptr && get_delegate_fptr && close_fptr;
 }
@@ -18,7 +18,10 @@
 --------------------------------------------------------------------------*/
 
 #pragma once
+#include <chrono>
+
 #include "include.hpp"
+#include "StartupCache.hpp"
 
 constexpr auto NETHOST_SUCCESS = 0;
 constexpr auto NETHOST_ERROR_LOAD_HOSTFXR = 1;
@@ -31,6 +34,7 @@ constexpr auto NETHOST_ERROR_GET_EXPORT = 6;
 class NetHost
 {
 public:
+	explicit NetHost(StartupCache* startupCache = nullptr);
 	~NetHost();
 	int GetMethodFromAssembly(
 		const char_t* binaryPath,
@@ -40,16 +44,29 @@ public:
 		const char_t* delegateName,
 		void** methodPointer);
 
+	// Time it took to load hostfxr and initialize the runtime - zero until the runtime was initialized
+	[[nodiscard]] static std::chrono::microseconds GetStartupDuration() { return startupDuration; }
+
+	// Whether hostfxr was loaded from the location in the startup cache
+	[[nodiscard]] static bool IsHostFxrFromStartupCache() { return hostFxrFromStartupCache; }
+
 private:
-	load_assembly_and_get_function_pointer_fn get_function_pointer_fptr = nullptr;
-	hostfxr_initialize_for_runtime_config_fn init_fptr = nullptr;
-	hostfxr_get_runtime_delegate_fn get_delegate_fptr = nullptr;
-	hostfxr_close_fn close_fptr = nullptr;
+	// hostfxr and the runtime are loaded once per process and shared by all measures
+	static load_assembly_and_get_function_pointer_fn get_function_pointer_fptr;
+	static hostfxr_initialize_for_runtime_config_fn init_fptr;
+	static hostfxr_get_runtime_delegate_fn get_delegate_fptr;
+	static hostfxr_close_fn close_fptr;
+	static std::chrono::microseconds startupDuration;
+	static bool hostFxrFromStartupCache;
+
+	// Optional cache of the hostfxr location shared by all measures
+	StartupCache* startupCache;
 
 	int LoadHostFxr();
-	[[nodiscard]] bool IsHostFxrLoaded() const;
+	static int LoadHostFxr(const char_t* path);
+	[[nodiscard]] static bool IsHostFxrLoaded();
 
-	int GetAssemblyFunctionLoader(
+	static int GetAssemblyFunctionLoader(
 		const char_t* config_path,
 		load_assembly_and_get_function_pointer_fn& loadAssemblyAndGetFunction);
 	
@@ -23,61 +23,86 @@
 #include "Plugin.hpp"
 #include "NetHost.hpp"
 #include "MeasureShim.hpp"
+#include "StartupCache.hpp"
 
 #define DIR_SEPARATOR L'\\'
 
-string_t* GetShimBinaryDirectory()
+namespace
 {
-	HMODULE hm = nullptr;
+	// Resolved once per process and shared by all measures
+	string_t* pluginFilePath = nullptr;
+	string_t* pluginType = nullptr;
+	StartupCache* startupCache = nullptr;
 
-	if (GetModuleHandleExW(
-		GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
-		reinterpret_cast<LPCWSTR>(&GetShimBinaryDirectory),
-		&hm) == 0)
+	string_t* GetShimBinaryDirectory()
 	{
-		return nullptr;
-	}
+		HMODULE hm = nullptr;
 
-	std::vector<wchar_t> pathBuffer;
-	DWORD copied;
-	do {
-		pathBuffer.resize(pathBuffer.size() + MAX_PATH);
-		copied = GetModuleFileNameW(hm, pathBuffer.data(), static_cast<DWORD>(pathBuffer.size()));
-		if (copied == 0)
+		if (GetModuleHandleExW(
+			GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+			reinterpret_cast<LPCWSTR>(&GetShimBinaryDirectory),
+			&hm) == 0)
 		{
 			return nullptr;
 		}
-	} while (copied >= pathBuffer.size());
 
-	pathBuffer.resize(copied);
+		std::vector<wchar_t> pathBuffer;
+		DWORD copied;
+		do {
+			pathBuffer.resize(pathBuffer.size() + MAX_PATH);
+			copied = GetModuleFileNameW(hm, pathBuffer.data(), static_cast<DWORD>(pathBuffer.size()));
+			if (copied == 0)
+			{
+				return nullptr;
+			}
+		} while (copied >= pathBuffer.size());
+
+		pathBuffer.resize(copied);
+
+		string_t rootPath = pathBuffer.data();
+		const auto pos = rootPath.find_last_of(DIR_SEPARATOR);
+		if (pos == string_t::npos)
+		{
+			return nullptr;
+		}
 
-	string_t rootPath = pathBuffer.data();
-	const auto pos = rootPath.find_last_of(DIR_SEPARATOR);
-	if (pos == string_t::npos)
-	{
-		return nullptr;
+		rootPath = rootPath.substr(0, pos + 1);
+		return new string_t(rootPath);
 	}
 
-	rootPath = rootPath.substr(0, pos + 1);
-	return new string_t(rootPath);
+	void ResolvePluginFiles()
+	{
+		if (pluginFilePath != nullptr)
+		{
+			return;
+		}
+
+		const auto rootPath = GetShimBinaryDirectory();
+		pluginFilePath = new string_t(*rootPath + PLUGIN_NAME_STRING + DIR_SEPARATOR + PLUGIN_NAME_STRING);
+		delete rootPath;
+
+		pluginType = new string_t(string_t(PLUGIN_NAME_STRING) + L".NativeInterop.Plugin, " + PLUGIN_NAME_STRING);
+
+		// The startup cache lives next to the dotnet plugin and is validated when the runtime is loaded
+		startupCache = new StartupCache(*pluginFilePath + L".shimcache", *pluginFilePath + L".runtimeconfig.json");
+	}
 }
 
 PLUGIN_EXPORT void Initialize(void** data, void* rm)
 {
-	const auto rootPath = GetShimBinaryDirectory();
-	const auto pluginFilePath = *rootPath + PLUGIN_NAME_STRING + DIR_SEPARATOR + PLUGIN_NAME_STRING;
-	const auto pluginType = string_t(PLUGIN_NAME_STRING) + L".NativeInterop.Plugin, " + PLUGIN_NAME_STRING;
-	delete rootPath;
+	ResolvePluginFiles();
 
 	const auto measure = new Measure(
-		string_t(pluginFilePath + L".dll"),
-		string_t(pluginFilePath + L".runtimeconfig.json"),
-		string_t(pluginType));
+		string_t(*pluginFilePath + L".dll"),
+		string_t(*pluginFilePath + L".runtimeconfig.json"),
+		string_t(*pluginType),
+		startupCache);
 
-	RmLog(rm, LOG_DEBUG, pluginFilePath.c_str());
-	RmLog(rm, LOG_DEBUG, pluginType.c_str());
+	RmLog(rm, LOG_DEBUG, pluginFilePath->c_str());
+	RmLog(rm, LOG_DEBUG, pluginType->c_str());
 
 	measure->Initialize(rm);
+	startupCache->Save();
 	*data = measure;
 }
 
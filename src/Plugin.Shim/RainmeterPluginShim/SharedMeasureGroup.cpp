@@ -0,0 +1,111 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#include "SharedMeasureGroup.hpp"
+
+#include <algorithm>
+#include <cwctype>
+
+std::unordered_map<string_t, std::weak_ptr<SharedMeasureGroup>> SharedMeasureGroup::groups;
+
+namespace
+{
+	string_t Trim(const string_t& value)
+	{
+		const auto first = std::find_if_not(value.begin(), value.end(), std::iswspace);
+		const auto last = std::find_if_not(value.rbegin(), value.rend(), std::iswspace).base();
+		return first < last ? string_t(first, last) : string_t();
+	}
+}
+
+SharedMeasureGroup::SharedMeasureGroup(string_t key)
+	: key(std::move(key))
+{
+}
+
+string_t SharedMeasureGroup::BuildKey(void* rm)
+{
+	// Option names are case insensitive in rainmeter and their order should not matter
+	std::vector<string_t> optionNames;
+	const string_t sharedOptions = RmReadString(rm, L"SharedOptions", L"", FALSE);
+	size_t start = 0;
+	while (start <= sharedOptions.size())
+	{
+		auto end = sharedOptions.find(L'|', start);
+		if (end == string_t::npos)
+		{
+			end = sharedOptions.size();
+		}
+
+		auto optionName = Trim(sharedOptions.substr(start, end - start));
+		if (!optionName.empty())
+		{
+			std::transform(optionName.begin(), optionName.end(), optionName.begin(), std::towlower);
+			optionNames.push_back(std::move(optionName));
+		}
+
+		start = end + 1;
+	}
+
+	std::sort(optionNames.begin(), optionNames.end());
+	optionNames.erase(std::unique(optionNames.begin(), optionNames.end()), optionNames.end());
+
+	string_t key;
+	for (const auto& optionName : optionNames)
+	{
+		key += optionName;
+		key += L'=';
+		key += Trim(RmReadString(rm, optionName.c_str(), L"", TRUE));
+		key += L'\n';
+	}
+
+	return key;
+}
+
+std::shared_ptr<SharedMeasureGroup> SharedMeasureGroup::Join(const string_t& key, Measure* subscriber)
+{
+	auto group = groups[key].lock();
+	if (group == nullptr)
+	{
+		group = std::make_shared<SharedMeasureGroup>(key);
+		groups[key] = group;
+	}
+
+	group->subscribers.push_back(subscriber);
+	return group;
+}
+
+Measure* SharedMeasureGroup::Leave(const std::shared_ptr<SharedMeasureGroup>& group, Measure* subscriber)
+{
+	const bool wasHost = group->GetHost() == subscriber;
+	std::erase(group->subscribers, subscriber);
+
+	if (group->subscribers.empty())
+	{
+		groups.erase(group->key);
+		return nullptr;
+	}
+
+	return wasHost ? group->GetHost() : nullptr;
+}
+
+Measure* SharedMeasureGroup::GetHost() const
+{
+	return subscribers.empty() ? nullptr : subscribers.front();
+}
@@ -0,0 +1,76 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#pragma once
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "include.hpp"
+
+class Measure;
+
+// Group of measures with an identical plugin option fingerprint that share a single .NET plugin instance.
+// All members are only accessed from the rainmeter main thread so no synchronization is necessary.
+class SharedMeasureGroup
+{
+public:
+	explicit SharedMeasureGroup(string_t key);
+
+	// Builds the normalized fingerprint of the options listed in the "SharedOptions" option of the measure
+	// Returns an empty string if no options are listed because the measure must not be shared then.
+	static string_t BuildKey(void* rm);
+
+	// Adds the measure to the group with the given key - the group is created if it does not exist yet
+	static std::shared_ptr<SharedMeasureGroup> Join(const string_t& key, Measure* subscriber);
+
+	// Removes the measure from the group and returns the new host if the leaving measure was the host
+	static Measure* Leave(const std::shared_ptr<SharedMeasureGroup>& group, Measure* subscriber);
+
+	// Measure that holds the .NET plugin instance of the group
+	[[nodiscard]] Measure* GetHost() const;
+
+	// Result of the last update of the .NET plugin
+	double value = 0.0;
+
+	// Whether the .NET plugin returned a string in the last update
+	bool hasString = false;
+
+	// String result of the last update of the .NET plugin
+	string_t stringValue;
+
+	// Max value set by the .NET plugin on reload
+	double maxValue = 0.0;
+
+	// Incremented whenever the .NET plugin has been updated
+	unsigned long long generation = 0;
+
+	// Whether the host already created its .NET plugin instance - a new host starts it on first use
+	bool isHostStarted = false;
+
+private:
+	// Fingerprint of the group
+	string_t key;
+
+	// Measures subscribed to the group - the first one is the host
+	std::vector<Measure*> subscribers;
+
+	// All groups of the plugin by their fingerprint
+	static std::unordered_map<string_t, std::weak_ptr<SharedMeasureGroup>> groups;
+};
@@ -0,0 +1,243 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#include "StartupCache.hpp"
+
+#include <cstdio>
+#include <format>
+#include <string_view>
+#include <vector>
+
+constexpr auto STARTUP_CACHE_VERSION = L"2";
+
+StartupCache::StartupCache(string_t filePath, string_t runtimeConfigPath)
+	: filePath(std::move(filePath))
+	, runtimeConfigPath(std::move(runtimeConfigPath))
+{
+}
+
+bool StartupCache::Load()
+{
+	loaded = false;
+	hostFxrPath.clear();
+
+	const auto values = ReadFile();
+	const auto cachedHostFxrPath = values.find(L"HostFxrPath");
+	if (cachedHostFxrPath == values.end() || cachedHostFxrPath->second.empty())
+	{
+		return false;
+	}
+
+	for (const auto& [key, value] : GetValidationValues(cachedHostFxrPath->second))
+	{
+		const auto cachedValue = values.find(key);
+		if (cachedValue == values.end() || cachedValue->second != value)
+		{
+			return false;
+		}
+	}
+
+	hostFxrPath = cachedHostFxrPath->second;
+	loaded = true;
+	changed = false;
+	return true;
+}
+
+bool StartupCache::Save()
+{
+	if (!changed || hostFxrPath.empty())
+	{
+		return true;
+	}
+
+	// Only try once per process - a read-only plugin folder would otherwise cost a failed write on every measure
+	changed = false;
+
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, filePath.c_str(), L"wb") != 0 || file == nullptr)
+	{
+		return false;
+	}
+
+	// UTF-16 with BOM so the file can be inspected with any editor
+	string_t content = L"\xFEFF";
+	content += std::format(L"HostFxrPath={}\r\n", hostFxrPath);
+	for (const auto& [key, value] : GetValidationValues(hostFxrPath))
+	{
+		content += std::format(L"{}={}\r\n", key, value);
+	}
+
+	const bool written = fwrite(content.data(), sizeof(wchar_t), content.size(), file) == content.size();
+	return fclose(file) == 0 && written;
+}
+
+void StartupCache::SetHostFxrPath(const string_t& path)
+{
+	if (hostFxrPath != path)
+	{
+		hostFxrPath = path;
+		changed = true;
+	}
+}
+
+std::unordered_map<string_t, string_t> StartupCache::ReadFile() const
+{
+	std::unordered_map<string_t, string_t> values;
+
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, filePath.c_str(), L"rb") != 0 || file == nullptr)
+	{
+		return values;
+	}
+
+	// The file is tiny so it is read at once
+	std::vector<wchar_t> buffer(4096);
+	size_t length = 0;
+	size_t read;
+	while ((read = fread(buffer.data() + length, sizeof(wchar_t), buffer.size() - length, file)) > 0)
+	{
+		length += read;
+		if (length == buffer.size())
+		{
+			buffer.resize(buffer.size() * 2);
+		}
+	}
+
+	const bool failed = ferror(file) != 0;
+	fclose(file);
+	if (failed || length == 0 || buffer[0] != L'\xFEFF')
+	{
+		return values;
+	}
+
+	const std::wstring_view content(buffer.data() + 1, length - 1);
+	size_t lineStart = 0;
+	while (lineStart < content.size())
+	{
+		auto lineEnd = content.find(L'\n', lineStart);
+		if (lineEnd == std::wstring_view::npos)
+		{
+			lineEnd = content.size();
+		}
+
+		auto line = content.substr(lineStart, lineEnd - lineStart);
+		if (!line.empty() && line.back() == L'\r')
+		{
+			line.remove_suffix(1);
+		}
+
+		const auto separator = line.find(L'=');
+		if (separator != std::wstring_view::npos)
+		{
+			values.emplace(string_t(line.substr(0, separator)), string_t(line.substr(separator + 1)));
+		}
+
+		lineStart = lineEnd + 1;
+	}
+
+	return values;
+}
+
+std::unordered_map<string_t, string_t> StartupCache::GetValidationValues(const string_t& path) const
+{
+	// hostfxr is located in "{dotnet root}\host\fxr\{version}\" and a newer version is used as soon as it is installed
+	string_t versionsPath;
+	const auto versionPos = path.find_last_of(L'\\');
+	if (versionPos != string_t::npos && versionPos > 0)
+	{
+		const auto versionsPos = path.find_last_of(L'\\', versionPos - 1);
+		if (versionsPos != string_t::npos)
+		{
+			versionsPath = path.substr(0, versionsPos);
+		}
+	}
+
+	return {
+		{ L"Version", STARTUP_CACHE_VERSION },
+		{ L"Plugin", PLUGIN_NAME_STRING },
+		{ L"PluginVersion", PLUGIN_VERSION_STRING },
+		{ L"RuntimeConfigHash", GetFileHash(runtimeConfigPath) },
+		{ L"DotnetRoot", GetDotnetRoot() },
+		{ L"HostFxrStamp", GetFileStamp(path) },
+		{ L"HostFxrVersionsStamp", versionsPath.empty() ? L"" : GetFileStamp(versionsPath) },
+	};
+}
+
+string_t StartupCache::GetDotnetRoot()
+{
+	string_t dotnetRoot;
+	for (const auto name : { L"DOTNET_ROOT", L"DOTNET_ROOT_X64", L"DOTNET_ROOT_X86", L"DOTNET_ROOT(x86)" })
+	{
+		std::vector<wchar_t> buffer(MAX_PATH);
+		auto length = GetEnvironmentVariableW(name, buffer.data(), static_cast<DWORD>(buffer.size()));
+		if (length >= buffer.size())
+		{
+			// The returned length includes the terminating null character if the buffer was too small
+			buffer.resize(length);
+			length = GetEnvironmentVariableW(name, buffer.data(), static_cast<DWORD>(buffer.size()));
+		}
+
+		if (length > 0 && length < buffer.size())
+		{
+			dotnetRoot += std::format(L"{}:{};", name, std::wstring_view(buffer.data(), length));
+		}
+	}
+
+	return dotnetRoot;
+}
+
+string_t StartupCache::GetFileStamp(const string_t& path)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes) == FALSE)
+	{
+		return L"";
+	}
+
+	return std::format(
+		L"{:08X}{:08X}-{:08X}{:08X}",
+		attributes.ftLastWriteTime.dwHighDateTime,
+		attributes.ftLastWriteTime.dwLowDateTime,
+		attributes.nFileSizeHigh,
+		attributes.nFileSizeLow);
+}
+
+string_t StartupCache::GetFileHash(const string_t& path)
+{
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, path.c_str(), L"rb") != 0 || file == nullptr)
+	{
+		return L"";
+	}
+
+	unsigned long long hash = 14695981039346656037ull;
+	unsigned char buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof buffer, file)) > 0)
+	{
+		for (size_t i = 0; i < read; ++i)
+		{
+			hash = (hash ^ buffer[i]) * 1099511628211ull;
+		}
+	}
+
+	const bool failed = ferror(file) != 0;
+	fclose(file);
+	return failed ? L"" : std::format(L"{:016X}", hash);
+}
@@ -0,0 +1,67 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#pragma once
+#include <unordered_map>
+
+#include "include.hpp"
+
+// Persistent cache of the hostfxr location that is expensive to discover.
+// The cache is only used if it was created for the same plugin version, runtimeconfig, hostfxr binary and
+// dotnet installation (DOTNET_ROOT and the installed hostfxr versions).
+class StartupCache
+{
+public:
+	StartupCache(string_t filePath, string_t runtimeConfigPath);
+
+	// Loads the cache file - returns false if it does not exist or failed validation
+	bool Load();
+
+	// Writes the cache file if anything changed since it was loaded - a failed write is not retried, returns false on error
+	bool Save();
+
+	// Path of hostfxr or an empty string if unknown
+	[[nodiscard]] const string_t& GetHostFxrPath() const { return hostFxrPath; }
+	void SetHostFxrPath(const string_t& path);
+
+	// Whether the values were loaded from a valid cache file
+	[[nodiscard]] bool IsLoaded() const { return loaded; }
+
+private:
+	string_t filePath;
+	string_t runtimeConfigPath;
+	string_t hostFxrPath;
+	bool loaded = false;
+	bool changed = false;
+
+	// Reads all "key=value" lines of the cache file - empty if the file does not exist or is invalid
+	[[nodiscard]] std::unordered_map<string_t, string_t> ReadFile() const;
+
+	// Values that invalidate the cache when they change
+	[[nodiscard]] std::unordered_map<string_t, string_t> GetValidationValues(const string_t& path) const;
+
+	// Environment variables that override the dotnet install location
+	static string_t GetDotnetRoot();
+
+	// Identifies a version of a file or directory by its last write time and size - empty if it does not exist
+	static string_t GetFileStamp(const string_t& path);
+
+	// FNV-1a hash of the file content - empty if the file cannot be read
+	static string_t GetFileHash(const string_t& path);
+};
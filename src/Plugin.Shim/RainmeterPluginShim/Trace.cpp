@@ -0,0 +1,174 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+constexpr size_t TRACE_BUFFER_CAPACITY = 4096;
+constexpr char TRACE_FILE_MAGIC[8] = { 'S', 'H', 'I', 'M', 'T', 'R', 'C', '\0' };
+constexpr uint32_t TRACE_FILE_VERSION = 1;
+
+namespace
+{
+	// Ring buffer that is only written by its owning thread
+	struct TraceBuffer
+	{
+		std::array<TraceEvent, TRACE_BUFFER_CAPACITY> events{};
+		std::atomic<uint64_t> written = 0;
+	};
+
+	struct TraceFileHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t eventSize;
+		int64_t frequency;
+		uint64_t eventCount;
+	};
+
+	static_assert(sizeof(TraceFileHeader) == 32);
+
+	// Buffers of all threads that ever recorded an event - they live until the plugin is unloaded
+	// so events of finished threads are still available for dumping
+	std::mutex buffersMutex;
+	std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+	thread_local TraceBuffer* threadBuffer = nullptr;
+
+	TraceBuffer* GetThreadBuffer()
+	{
+		if (threadBuffer == nullptr)
+		{
+			auto buffer = std::make_unique<TraceBuffer>();
+			threadBuffer = buffer.get();
+
+			const std::lock_guard lock(buffersMutex);
+			buffers.push_back(std::move(buffer));
+		}
+
+		return threadBuffer;
+	}
+}
+
+std::atomic<bool> Trace::enabled = false;
+
+void Trace::SetEnabled(const bool value)
+{
+	enabled.store(value, std::memory_order_relaxed);
+}
+
+int64_t Trace::Now()
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return counter.QuadPart;
+}
+
+void Trace::Record(const TraceEvent& traceEvent)
+{
+	const auto buffer = GetThreadBuffer();
+	const auto index = buffer->written.load(std::memory_order_relaxed);
+	buffer->events[index % TRACE_BUFFER_CAPACITY] = traceEvent;
+	buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::Dump(const string_t& filePath)
+{
+	std::vector<TraceEvent> events;
+	{
+		const std::lock_guard lock(buffersMutex);
+		for (const auto& buffer : buffers)
+		{
+			const auto written = buffer->written.load(std::memory_order_acquire);
+			const auto first = written > TRACE_BUFFER_CAPACITY ? written - TRACE_BUFFER_CAPACITY : 0;
+			const auto offset = events.size();
+			for (auto index = first; index < written; ++index)
+			{
+				events.push_back(buffer->events[index % TRACE_BUFFER_CAPACITY]);
+			}
+
+			// Drop events the owning thread might have overwritten while they were copied - including the slot
+			// of the event at index "writtenAfterCopy" which might be written right now
+			const auto writtenAfterCopy = buffer->written.load(std::memory_order_acquire);
+			const auto firstValid = writtenAfterCopy + 1 > TRACE_BUFFER_CAPACITY
+				? writtenAfterCopy + 1 - TRACE_BUFFER_CAPACITY
+				: 0;
+			if (firstValid > first)
+			{
+				const auto invalid = static_cast<ptrdiff_t>(std::min(firstValid, written) - first);
+				events.erase(events.begin() + offset, events.begin() + offset + invalid);
+			}
+		}
+	}
+
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	TraceFileHeader header{};
+	std::copy_n(TRACE_FILE_MAGIC, sizeof header.magic, header.magic);
+	header.version = TRACE_FILE_VERSION;
+	header.eventSize = sizeof(TraceEvent);
+	header.frequency = frequency.QuadPart;
+	header.eventCount = events.size();
+
+	FILE* file = nullptr;
+	if (_wfopen_s(&file, filePath.c_str(), L"wb") != 0 || file == nullptr)
+	{
+		return false;
+	}
+
+	bool succeeded = fwrite(&header, sizeof header, 1, file) == 1;
+	if (succeeded && !events.empty())
+	{
+		succeeded = fwrite(events.data(), sizeof(TraceEvent), events.size(), file) == events.size();
+	}
+
+	return fclose(file) == 0 && succeeded;
+}
+
+TraceScope::TraceScope(const uint32_t measureId, const TraceEntryPoint entryPoint)
+	: active(Trace::IsEnabled())
+	, measureId(measureId)
+	, entryPoint(entryPoint)
+{
+	if (active)
+	{
+		start = Trace::Now();
+	}
+}
+
+TraceScope::~TraceScope()
+{
+	if (active)
+	{
+		Trace::Record(TraceEvent{
+			start,
+			Trace::Now() - start,
+			measureId,
+			static_cast<uint32_t>(GetCurrentThreadId()),
+			returnCode,
+			entryPoint });
+	}
+}
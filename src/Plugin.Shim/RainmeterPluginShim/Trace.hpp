@@ -0,0 +1,89 @@
+/* -----------------------------------------------------------------------
+	Copyright (C) 2023 whiskycompiler
+
+	This file is part of "Plugin.Shim".
+
+	This program is free software: you can redistribute it and/or
+	modify it under the terms of the GNU General Public License
+	as published by the Free Software Foundation, either version 3
+	of the License, or (at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+	See the GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program. If not, see <https://www.gnu.org/licenses/>.
+--------------------------------------------------------------------------*/
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+#include "include.hpp"
+
+constexpr auto TRACE_RESULT_SUCCESS = 0;
+constexpr auto TRACE_RESULT_FAILURE = 1;
+
+// Transitions from the shim into the dotnet plugin that can be traced
+enum class TraceEntryPoint : uint32_t
+{
+	Initialize = 0,
+	Update = 1,
+	Reload = 2,
+	GetString = 3,
+	ExecuteBang = 4,
+	CustomFunc = 5,
+	Finalize = 6,
+};
+
+// Single trace record - layout is part of the trace file format (see ConvertShimTrace.ps1)
+struct TraceEvent
+{
+	int64_t start; // QueryPerformanceCounter ticks
+	int64_t duration; // QueryPerformanceCounter ticks
+	uint32_t measureId;
+	uint32_t threadId;
+	int32_t returnCode;
+	TraceEntryPoint entryPoint;
+};
+
+static_assert(sizeof(TraceEvent) == 32);
+
+// Records shim-to-managed transitions into per-thread ring buffers while enabled
+class Trace
+{
+public:
+	static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+	static void SetEnabled(bool value);
+
+	static int64_t Now();
+	static void Record(const TraceEvent& traceEvent);
+
+	// Writes the events of all threads into a binary trace file - returns false on error
+	static bool Dump(const string_t& filePath);
+
+private:
+	static std::atomic<bool> enabled;
+};
+
+// Records a single trace event for its lifetime - does nothing if tracing was disabled on construction
+class TraceScope
+{
+public:
+	TraceScope(uint32_t measureId, TraceEntryPoint entryPoint);
+	~TraceScope();
+
+	TraceScope(const TraceScope&) = delete;
+	TraceScope& operator=(const TraceScope&) = delete;
+
+	void SetSucceeded() { returnCode = TRACE_RESULT_SUCCESS; }
+
+private:
+	const bool active;
+	const uint32_t measureId;
+	const TraceEntryPoint entryPoint;
+	int64_t start = 0;
+	int32_t returnCode = TRACE_RESULT_FAILURE;
+};
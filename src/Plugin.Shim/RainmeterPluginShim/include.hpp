@@ -37,4 +37,9 @@
 #endif
 #define PLUGIN_NAME_STRING WIDEN(PLUGIN_NAME)
 
+#ifndef PLUGIN_VERSION
+	#define PLUGIN_VERSION 1.0.0.0
+#endif
+#define PLUGIN_VERSION_STRING WIDEN(PLUGIN_VERSION)
+
 using string_t = std::basic_string<char_t>;
\ No newline at end of file
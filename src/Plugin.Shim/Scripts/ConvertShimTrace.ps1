@@ -0,0 +1,50 @@
+# Converts a binary shim trace (see "ShimTrace Dump" bang) into the Chrome trace event format
+# which can be opened with chrome://tracing or https://ui.perfetto.dev
+# Usage: powershell -file ConvertShimTrace.ps1 "path\to\Plugin.shimtrace" ["path\to\trace.json"]
+$ErrorActionPreference = "Stop"
+$inputPath = $args[0];
+$outputPath = if ($args.Count -gt 1) { $args[1] } else { [System.IO.Path]::ChangeExtension($inputPath, ".json") };
+$entryPoints = @("Initialize", "Update", "Reload", "GetString", "ExecuteBang", "CustomFunc", "Finalize");
+
+$reader = New-Object System.IO.BinaryReader([System.IO.File]::OpenRead($inputPath));
+try
+{
+    $magic = [System.Text.Encoding]::ASCII.GetString($reader.ReadBytes(8));
+    if ($magic -ne "SHIMTRC`0") { throw "'$inputPath' is not a shim trace file!"; }
+
+    $version = $reader.ReadUInt32();
+    if ($version -ne 1) { throw "Unsupported shim trace version $version!"; }
+
+    $eventSize = $reader.ReadUInt32();
+    $frequency = $reader.ReadInt64();
+    $eventCount = $reader.ReadUInt64();
+
+    $events = New-Object System.Collections.Generic.List[object];
+    for ($i = 0; $i -lt $eventCount; $i++)
+    {
+        $bytes = $reader.ReadBytes($eventSize);
+        $start = [BitConverter]::ToInt64($bytes, 0);
+        $duration = [BitConverter]::ToInt64($bytes, 8);
+        $measureId = [BitConverter]::ToUInt32($bytes, 16);
+        $threadId = [BitConverter]::ToUInt32($bytes, 20);
+        $returnCode = [BitConverter]::ToInt32($bytes, 24);
+        $entryPoint = [BitConverter]::ToUInt32($bytes, 28);
+
+        $events.Add([ordered]@{
+            name = if ($entryPoint -lt $entryPoints.Count) { $entryPoints[$entryPoint] } else { "EntryPoint$entryPoint" };
+            cat = "shim";
+            ph = "X";
+            ts = $start * 1000000.0 / $frequency;
+            dur = $duration * 1000000.0 / $frequency;
+            pid = 0;
+            tid = $threadId;
+            args = [ordered]@{ measureId = $measureId; returnCode = $returnCode };
+        });
+    }
+}
+finally
+{
+    $reader.Dispose();
+}
+
+Set-Content -Path $outputPath -Value ([ordered]@{ traceEvents = $events; displayTimeUnit = "ms" } | ConvertTo-Json -Depth 4 -Compress);